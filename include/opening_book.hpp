@@ -0,0 +1,32 @@
+/**
+ * opening_book.hpp - GENERATED by tools/generate_book. Do not edit.
+ *
+ * Exact scores for every position up to -1 plies, keyed by
+ * Position::canonical_key() and sorted for binary search.
+ */
+
+#ifndef OPENING_BOOK_HPP
+#define OPENING_BOOK_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace opening_book {
+
+// Deepest ply covered; -1 means the book is empty
+inline constexpr int MAX_PLIES = -1;
+
+struct Entry {
+    uint64_t key;   // Position::canonical_key()
+    int8_t score;   // Exact score for the player to move
+};
+
+inline constexpr Entry BOOK[] = {
+    {0, 0},  // placeholder so the array isn't empty
+};
+
+inline constexpr size_t SIZE = 0;
+
+}  // namespace opening_book
+
+#endif // OPENING_BOOK_HPP
@@ -45,70 +45,118 @@
 #ifndef POSITION_HPP
 #define POSITION_HPP
 
+// Everything below leans on bit-manipulation builtins (popcount for
+// nb_moves, ctz for walking move bitboards). On a generic x86-64 target
+// GCC lowers those to byte-table loops or libgcc calls; this pragma lets
+// it emit the real single-instruction forms (POPCNT, TZCNT, BLSR) for all
+// code that includes this header. Guarded so non-x86 and non-GCC builds
+// keep their portable fallbacks. (These instructions exist on every x86-64
+// CPU made since ~2013.)
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)
+#pragma GCC target("popcnt,bmi,bmi2")
+#endif
+
+#include <cstddef>  // For size_t (batch API lengths)
 #include <cstdint>  // For uint64_t (a 64-bit unsigned integer)
 #include <string>
 
-class Position {
+#if defined(__AVX2__)
+#include <immintrin.h>  // AVX2 intrinsics for the vectorized alignment()
+#endif
+
+// alignas(16): a Position is exactly two 64-bit words, so 16-byte
+// alignment guarantees any copy (the root tasks pass them by value)
+// sits in a single cache line and can move with one aligned 16-byte
+// load/store pair. The static_assert below keeps the struct honest -
+// if a field ever sneaks in, the "two registers" assumptions in the
+// solver's make/unmake path should be revisited.
+class alignas(16) Position {
 public:
     // Board dimensions
     static constexpr int WIDTH = 7;   // Number of columns
     static constexpr int HEIGHT = 6;  // Number of rows (playable)
 
-    // Constructor - creates an empty board
-    Position();
+    // Constructor - creates an empty board. constexpr (like the methods
+    // below) so whole test scenarios can be evaluated at compile time.
+    constexpr Position() : mask_(0), position_(0) {}
 
     // -------------------------------------------------------------------------
     // Helper Mask Functions (explained below)
     // -------------------------------------------------------------------------
+    //
+    // The per-column masks are materialized as compile-time LOOKUP TABLES
+    // rather than computed with shifts on every call. can_play, make_move,
+    // and is_winning_move ask for these masks up to seven times per search
+    // node; an indexed load from an L1-resident 56-byte table is cheaper
+    // than the multiply-and-shift chain and frees up registers in the
+    // inlined hot loop. (When `col` is a compile-time constant the table
+    // entry folds to an immediate either way.)
+
+    // One bit at the bottom cell of each column (bit col*7)
+    static constexpr uint64_t BOTTOM_MASKS[WIDTH] = {
+        1ULL << 0,  1ULL << 7,  1ULL << 14, 1ULL << 21,
+        1ULL << 28, 1ULL << 35, 1ULL << 42
+    };
+
+    // One bit at the top playable cell of each column (bit col*7 + 5)
+    static constexpr uint64_t TOP_MASKS[WIDTH] = {
+        1ULL << 5,  1ULL << 12, 1ULL << 19, 1ULL << 26,
+        1ULL << 33, 1ULL << 40, 1ULL << 47
+    };
+
+    // All six playable cells of each column (0x3F = six 1-bits)
+    static constexpr uint64_t COLUMN_MASKS[WIDTH] = {
+        0x3FULL << 0,  0x3FULL << 7,  0x3FULL << 14, 0x3FULL << 21,
+        0x3FULL << 28, 0x3FULL << 35, 0x3FULL << 42
+    };
 
     /**
      * bottom_mask(col) - Returns a bitboard with a single 1 at the BOTTOM of
      * the given column.
-     * 
+     *
      * Example: bottom_mask(0) returns:
      *   Bit 0 is set (binary: 0000...0001)
      *   This represents the bottom cell of column 0.
-     * 
+     *
      * Example: bottom_mask(3) returns:
      *   Bit 21 is set (binary: 0000...0010000000000000000000)
      *   This represents the bottom cell of column 3.
      */
     static constexpr uint64_t bottom_mask(int col) {
-        return 1ULL << (col * (HEIGHT + 1));
+        return BOTTOM_MASKS[col];
     }
 
     /**
      * column_mask(col) - Returns a bitboard with 1s in ALL playable cells of
      * the given column (6 bits set, not including the buffer bit).
-     * 
+     *
      * Example: column_mask(0) returns bits 0-5 set.
      * Example: column_mask(1) returns bits 7-12 set.
      */
     static constexpr uint64_t column_mask(int col) {
-        return ((1ULL << HEIGHT) - 1) << (col * (HEIGHT + 1));
+        return COLUMN_MASKS[col];
     }
 
     /**
      * top_mask(col) - Returns a bitboard with a single 1 at the TOP PLAYABLE
      * cell of the given column (row 5, NOT the buffer).
-     * 
+     *
      * This is useful for checking if a column is full.
      */
     static constexpr uint64_t top_mask(int col) {
-        return 1ULL << ((HEIGHT - 1) + col * (HEIGHT + 1));
+        return TOP_MASKS[col];
     }
 
     /**
      * bottom() - Returns a bitboard with 1s at the bottom of EVERY column.
      * Used for the "gravity trick" when making moves.
+     *
+     * This is just the BOTTOM_MASK constant below; returning it directly
+     * (instead of rebuilding it in a loop) guarantees every use folds to
+     * a compile-time immediate.
      */
     static constexpr uint64_t bottom() {
-        // This creates: bit 0 | bit 7 | bit 14 | bit 21 | bit 28 | bit 35 | bit 42
-        uint64_t result = 0;
-        for (int col = 0; col < WIDTH; ++col) {
-            result |= bottom_mask(col);
-        }
-        return result;
+        return BOTTOM_MASK;
     }
 
     // Pre-computed bottom mask for efficiency
@@ -130,8 +178,15 @@ public:
      * We check this by ANDing the mask with top_mask(col).
      * 
      * Returns: true if the column has space, false if full.
+     *
+     * Defined here in the header (not position.cpp) so the compiler can
+     * inline it into the solver's inner loop — it's called for every
+     * candidate move of every node, and a function call would cost more
+     * than the single AND it performs.
      */
-    bool can_play(int col) const;
+    constexpr bool can_play(int col) const {
+        return (mask_ & top_mask(col)) == 0;
+    }
 
     /**
      * make_move(col) - Drop a piece into the given column.
@@ -158,23 +213,54 @@ public:
      * The result has a 1 exactly where the new piece should go!
      * 
      * Precondition: can_play(col) must be true.
+     *
+     * Like can_play(), this lives in the header so it inlines into the
+     * search: it's three ALU ops once inlined.
      */
-    void make_move(int col);
+    constexpr void make_move(int col) {
+        // Switch perspective: position_ now holds the OTHER player's stones
+        // (they become the current player after this move).
+        position_ ^= mask_;
+
+        // Gravity trick: adding the bottom bit carries up to the first
+        // empty cell of the column, which is exactly where the piece lands.
+        // (No move counter to bump - nb_moves() counts the mask's bits.)
+        mask_ |= mask_ + bottom_mask(col);
+    }
+
+    /**
+     * unmake_move(prev_mask, prev_position) - Undo the latest make_move.
+     *
+     * The caller saves mask/position before moving and hands them back to
+     * restore; with the whole state in those two words, undoing is just
+     * two register writes. This lets the solver search an entire subtree
+     * on ONE Position instead of copying a fresh one per child.
+     */
+    constexpr void unmake_move(uint64_t prev_mask, uint64_t prev_position) {
+        mask_ = prev_mask;
+        position_ = prev_position;
+    }
 
     /**
      * nb_moves() - Returns the number of moves played so far.
+     *
+     * Every move adds exactly one stone to the mask, so the move count is
+     * just the number of set bits — a single POPCNT instruction. Deriving
+     * it from mask_ lets us drop a separate counter field, shrinking
+     * Position to 16 bytes (it's copied by value on every search node, so
+     * a smaller struct means less stack traffic).
      */
-    int nb_moves() const { return moves_; }
+    constexpr int nb_moves() const { return __builtin_popcountll(mask_); }
 
     /**
      * get_mask() - Returns the mask bitboard (for debugging/testing).
      */
-    uint64_t get_mask() const { return mask_; }
+    constexpr uint64_t get_mask() const { return mask_; }
 
     /**
      * get_position() - Returns the current player's position bitboard.
      */
-    uint64_t get_position() const { return position_; }
+    constexpr uint64_t get_position() const { return position_; }
 
     /**
      * key() - Generate a unique key for this position.
@@ -185,8 +271,50 @@ public:
      * 
      * Formula: position + mask + BOTTOM_MASK
      * This cleverly encodes both the stone positions AND whose turn it is.
+     *
+     * Branchless and inline: it compiles to two adds (BOTTOM_MASK folds
+     * into an immediate), so it's far cheaper than any Zobrist-style hash.
+     * The solver computes it once per node and reuses the result for the
+     * TT prefetch, probe, and store.
+     */
+    constexpr uint64_t key() const { return position_ + mask_ + BOTTOM_MASK; }
+
+    /**
+     * mirror(bb) - Reflect a bitboard left-to-right (column c -> 6-c).
+     *
+     * Columns are independent 7-bit groups, so mirroring is just moving
+     * each group to its reflected slot: columns 0 and 6 trade places
+     * (42 bits apart), 1 and 5 (28 bits), 2 and 4 (14 bits), and the
+     * center column stays put. About a dozen branchless bit ops.
+     */
+    static constexpr uint64_t mirror(uint64_t bb) {
+        constexpr uint64_t COL = (1ULL << (HEIGHT + 1)) - 1;  // one 7-bit column
+        return ((bb & COL) << 42)
+             | ((bb & (COL << 7)) << 28)
+             | ((bb & (COL << 14)) << 14)
+             |  (bb & (COL << 21))
+             | ((bb & (COL << 28)) >> 14)
+             | ((bb & (COL << 35)) >> 28)
+             | ((bb & (COL << 42)) >> 42);
+    }
+
+    /**
+     * canonical_key() - A key shared by a position and its mirror image.
+     *
+     * Connect 4 is left/right symmetric: a position and its reflection
+     * always have the same game value. By keying the transposition table
+     * with min(key, mirrored key), both versions of a position land on
+     * the SAME entry — solving one subtree instantly answers its mirror
+     * twin, which roughly doubles the table's effective capacity.
+     *
+     * Only the key is canonicalized; moves are still made on the real
+     * (un-mirrored) board.
      */
-    uint64_t key() const { return position_ + mask_ + BOTTOM_MASK; }
+    constexpr uint64_t canonical_key() const {
+        uint64_t k = key();
+        uint64_t mk = mirror(position_) + mirror(mask_) + BOTTOM_MASK;
+        return k < mk ? k : mk;
+    }
 
     /**
      * is_winning_move(col) - Check if playing in this column wins the game.
@@ -214,8 +342,247 @@ public:
      *   if (m & (m >> 12))
      * 
      * We check if the OPPONENT just won (they played last move).
+     *
+     * Both alignment() and is_winning_move() are defined here in the
+     * header so they inline into the solver's inner loop — as out-of-line
+     * functions in position.cpp they cost a call/ret per candidate move,
+     * and the compiler couldn't share the `mask_ + bottom_mask(col)`
+     * computation with make_move().
+     */
+#if defined(__AVX2__)
+    /**
+     * alignment_avx2 - All four direction checks in two vector steps.
+     *
+     * The four scalar checks share one shape: m = pos & (pos >> k), then
+     * m & (m >> 2k). With AVX2's per-lane variable shift we can run all
+     * four strides (7, 1, 8, 6) side by side in one 256-bit register:
+     * two shifts and two ANDs total instead of four of each, and no
+     * early-exit branches for the predictor to learn.
+     */
+    static bool alignment_avx2(uint64_t pos) {
+        const __m256i v = _mm256_set1_epi64x(static_cast<long long>(pos));
+        const __m256i s1 = _mm256_set_epi64x(6, 8, 1, 7);  // strides per lane
+        const __m256i s2 = _mm256_slli_epi64(s1, 1);       // doubled strides
+
+        __m256i m = _mm256_and_si256(v, _mm256_srlv_epi64(v, s1));
+        __m256i r = _mm256_and_si256(m, _mm256_srlv_epi64(m, s2));
+
+        // testz returns 1 iff every lane is zero, i.e. no 4-in-a-row
+        return !_mm256_testz_si256(r, r);
+    }
+#endif
+
+    static constexpr bool alignment(uint64_t pos) {
+#if defined(__AVX2__) && (defined(__clang__) || __GNUC__ >= 9)
+        // Runtime calls take the vector path; constant evaluation (which
+        // can't touch intrinsics) falls through to the scalar checks.
+        if (!__builtin_is_constant_evaluated()) {
+            return alignment_avx2(pos);
+        }
+#endif
+        // Check HORIZONTAL (columns are 7 bits apart)
+        uint64_t m = pos & (pos >> 7);
+        if (m & (m >> 14)) return true;
+
+        // Check VERTICAL (rows are 1 bit apart)
+        m = pos & (pos >> 1);
+        if (m & (m >> 2)) return true;
+
+        // Check DIAGONAL / (going up-right = row + column = 8 bits)
+        m = pos & (pos >> 8);
+        if (m & (m >> 16)) return true;
+
+        // Check DIAGONAL \ (going up-left = row - column = 6 bits)
+        m = pos & (pos >> 6);
+        return (m & (m >> 12)) != 0;
+    }
+
+    constexpr bool is_winning_move(int col) const {
+        // Just a bit-test against the batched winning-moves mask: all
+        // seven columns' answers come out of ONE
+        // compute_winning_positions() pass, so callers interested in
+        // several columns should grab winning_moves() once and test bits
+        // themselves rather than calling this per column.
+        return (winning_moves() & column_mask(col)) != 0;
+    }
+
+    /**
+     * playable_moves() - Bitboard of the landing square in EVERY open column.
+     *
+     * One 64-bit add computes all seven landing squares at once:
+     * adding BOTTOM_MASK to the mask makes a carry ripple up each column
+     * to its first empty cell (the same gravity trick as make_move, but
+     * for all columns in parallel). ANDing with BOARD_MASK discards the
+     * carry into the buffer row of any full column.
+     *
+     * Returns: one set bit per playable column, at the cell where a piece
+     * dropped there would land. Zero if the board is full.
+     */
+    constexpr uint64_t playable_moves() const {
+        return (mask_ + BOTTOM_MASK) & BOARD_MASK;
+    }
+
+    /**
+     * compute_winning_positions() - Every empty square where dropping one
+     * of `player`'s stones would complete a 4-in-a-row.
+     *
+     * This finds the threats in ALL columns and ALL four directions with
+     * one straight-line sequence of shifts and ANDs — no loop, no
+     * per-column work. The idea per direction (stride k = 1 vertical,
+     * 7 horizontal, 8 diagonal /, 6 diagonal \):
+     *
+     *   (p << k) & (p << 2k) & (p << 3k) marks squares with three own
+     *   stones in a row BELOW/BESIDE them — completing squares.
+     *
+     * For the non-vertical directions the three stones can also straddle
+     * the gap (X X . X and X . X X patterns), so each direction combines
+     * a "pair" term with one more stone on either side, in both shift
+     * directions.
+     *
+     * The result is masked to EMPTY board squares. Intersect it with
+     * playable_moves() to get immediately playable wins, or use it raw to
+     * count threats for move ordering.
+     */
+#if defined(__AVX2__)
+    /**
+     * compute_winning_positions_avx2 - The same threat computation with
+     * the four directions in four 64-bit lanes.
+     *
+     * Each lane runs the full symmetric pattern (pair plus one stone on
+     * either side, both shift directions) for its stride - 1, 7, 6, 8 -
+     * via per-lane variable shifts, then the lanes are OR-reduced. The
+     * extra symmetric terms this adds to the VERTICAL lane only match
+     * an empty square with own stones above it, which gravity makes
+     * impossible, so the result is identical to the scalar version for
+     * any reachable position.
+     *
+     * Six vector shifts + a handful of ANDs/ORs replace ~20 scalar
+     * shifts and ANDs on the hottest kernel in the solver (threats are
+     * recomputed up to eight times per node for pruning and ordering).
+     */
+    [[nodiscard]] static uint64_t
+    compute_winning_positions_avx2(uint64_t player, uint64_t mask) noexcept {
+        const __m256i p = _mm256_set1_epi64x(static_cast<long long>(player));
+        const __m256i k1 = _mm256_set_epi64x(8, 6, 7, 1);  // strides per lane
+        const __m256i k2 = _mm256_slli_epi64(k1, 1);
+        const __m256i k3 = _mm256_add_epi64(k1, k2);
+
+        const __m256i l1 = _mm256_sllv_epi64(p, k1);
+        const __m256i r1 = _mm256_srlv_epi64(p, k1);
+
+        // pl = pair below/beside in the shift-left sense, pr mirrored
+        const __m256i pl = _mm256_and_si256(l1, _mm256_sllv_epi64(p, k2));
+        const __m256i pr = _mm256_and_si256(r1, _mm256_srlv_epi64(p, k2));
+
+        __m256i acc = _mm256_or_si256(
+            _mm256_or_si256(_mm256_and_si256(pl, _mm256_sllv_epi64(p, k3)),
+                            _mm256_and_si256(pl, r1)),
+            _mm256_or_si256(_mm256_and_si256(pr, l1),
+                            _mm256_and_si256(pr, _mm256_srlv_epi64(p, k3))));
+
+        // OR the four lanes together: 256 -> 128 -> 64 bits
+        __m128i or128 = _mm_or_si128(_mm256_castsi256_si128(acc),
+                                     _mm256_extracti128_si256(acc, 1));
+        uint64_t r = static_cast<uint64_t>(_mm_cvtsi128_si64(or128))
+                   | static_cast<uint64_t>(_mm_extract_epi64(or128, 1));
+
+        // Keep only EMPTY squares on the board
+        return r & (BOARD_MASK ^ mask);
+    }
+#endif
+
+    [[nodiscard]] static constexpr uint64_t
+    compute_winning_positions(uint64_t player, uint64_t mask) noexcept {
+#if defined(__AVX2__) && (defined(__clang__) || __GNUC__ >= 9)
+        // Same dispatch as alignment(): vector path at runtime, scalar
+        // path under constant evaluation (where intrinsics are barred).
+        if (!__builtin_is_constant_evaluated()) {
+            return compute_winning_positions_avx2(player, mask);
+        }
+#endif
+        // Vertical: three own stones directly below
+        uint64_t r = (player << 1) & (player << 2) & (player << 3);
+
+        // Horizontal (stride 7), including split patterns
+        uint64_t p = (player << 7) & (player << 14);
+        r |= p & (player << 21);
+        r |= p & (player >> 7);
+        p = (player >> 7) & (player >> 14);
+        r |= p & (player << 7);
+        r |= p & (player >> 21);
+
+        // Diagonal \ (stride 6)
+        p = (player << 6) & (player << 12);
+        r |= p & (player << 18);
+        r |= p & (player >> 6);
+        p = (player >> 6) & (player >> 12);
+        r |= p & (player << 6);
+        r |= p & (player >> 18);
+
+        // Diagonal / (stride 8)
+        p = (player << 8) & (player << 16);
+        r |= p & (player << 24);
+        r |= p & (player >> 8);
+        p = (player >> 8) & (player >> 16);
+        r |= p & (player << 8);
+        r |= p & (player >> 24);
+
+        // Keep only EMPTY squares on the board
+        return r & (BOARD_MASK ^ mask);
+    }
+
+    /**
+     * winning_moves() - Bitboard of landing squares that win immediately
+     * for the current player.
+     *
+     * The intersection of the current player's threat squares with the
+     * playable squares. Callers can iterate the set bits (bit / 7 gives
+     * the column) instead of asking is_winning_move() seven times.
      */
-    bool is_winning_move(int col) const;
+    constexpr uint64_t winning_moves() const {
+        return compute_winning_positions(position_, mask_) & playable_moves();
+    }
+
+    /**
+     * winning_mask_batch - "Can the side to move win at once?" for N
+     * positions given as parallel {mask, player} arrays.
+     *
+     * Struct-of-arrays form for callers that evaluate whole frontiers
+     * of candidate positions (batch tools, test drivers): the
+     * __restrict qualifiers promise the arrays don't overlap, so the
+     * compiler may unroll and vectorize the loop across positions
+     * instead of proving non-aliasing per iteration. out_wins[i] is 1
+     * if position i has at least one immediately winning column, 0
+     * otherwise.
+     */
+    static void winning_mask_batch(const uint64_t* __restrict masks,
+                                   const uint64_t* __restrict players,
+                                   uint8_t* __restrict out_wins,
+                                   size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            const uint64_t playable = (masks[i] + BOTTOM_MASK) & BOARD_MASK;
+            out_wins[i] =
+                (compute_winning_positions(players[i], masks[i]) & playable)
+                    ? 1
+                    : 0;
+        }
+    }
+
+#ifdef MARLIN_TESTING
+    /**
+     * fill_column_debug - TEST-ONLY: fill a whole column in one OR.
+     *
+     * Test harnesses that need "column c is full" as a precondition can
+     * set it up with one operation instead of six dependent make_move
+     * carry chains. The stones are all credited to the OPPONENT
+     * (position_ is untouched), so there is no pretence of a legal
+     * alternation history - which is why this is fenced behind the
+     * MARLIN_TESTING define and never compiled into the engine.
+     */
+    constexpr void fill_column_debug(int col) {
+        mask_ |= column_mask(col);
+    }
+#endif
 
     /**
      * display() - Print the board to stdout for debugging.
@@ -226,7 +593,14 @@ public:
      *   '.' for empty cells
      * 
      * Prints column numbers at the bottom (1-7).
+     *
+     * Marked cold/noinline: this is I/O-bound debug output that must
+     * never be inlined next to the search-critical code above, where it
+     * would bloat the instruction-cache footprint of the hot loop.
      */
+#if defined(__GNUC__)
+    [[gnu::cold]] [[gnu::noinline]]
+#endif
     void display() const;
 
 private:
@@ -250,12 +624,12 @@ private:
      */
     uint64_t position_;
 
-    /**
-     * moves - How many moves have been played (0 to 42).
-     * Used to determine whose turn it is (even = player 1, odd = player 2)
-     * and to detect draws (42 moves = full board).
-     */
-    int moves_;
+    // Note: there is deliberately NO move counter. The number of moves is
+    // the number of stones on the board, which nb_moves() computes from
+    // mask_ with a single popcount. See nb_moves() for why.
 };
 
+static_assert(sizeof(Position) == 16,
+              "Position must stay two bare bitboards (16 bytes)");
+
 #endif // POSITION_HPP
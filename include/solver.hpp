@@ -46,6 +46,33 @@
 
 class Solver {
 public:
+    /**
+     * Constructors - A solver either owns a private transposition table
+     * (the default) or borrows a SHARED one.
+     *
+     * Sharing matters for the parallel root analysis: the seven root
+     * subtrees transpose into each other constantly (e.g. 1-then-2 and
+     * 2-then-1 reach the same position), so with private tables each
+     * thread re-searches work a sibling already finished. One shared
+     * table lets every thread prune on everyone else's results — and it
+     * uses one 64 MB allocation instead of seven. The table itself is
+     * safe to share (see the thread-safety note in transposition.hpp).
+     *
+     * The borrowed table must outlive the solver; the caller keeps
+     * ownership.
+     */
+    Solver() : tt_(new TranspositionTable()), owns_tt_(true) {}
+    explicit Solver(TranspositionTable& shared_tt)
+        : tt_(&shared_tt), owns_tt_(false) {}
+
+    ~Solver() {
+        if (owns_tt_) delete tt_;
+    }
+
+    // node_count_/tt_ bookkeeping doesn't survive copying sensibly
+    Solver(const Solver&) = delete;
+    Solver& operator=(const Solver&) = delete;
+
     /**
      * solve - Find the game-theoretic value of a position.
      * 
@@ -70,24 +97,44 @@ public:
 
     // Move ordering: center columns first (better for alpha-beta pruning)
     // Column indices: 3, 2, 4, 1, 5, 0, 6 (center to edges, 0-indexed)
-    static constexpr int COLUMN_ORDER[7] = {3, 2, 4, 1, 5, 0, 6};
+    //
+    // The order is packed one column per byte into a single 64-bit
+    // constant instead of a static array: the whole ordering then lives
+    // in one register (a shift and a mask per lookup) rather than being
+    // re-loaded from memory each iteration, and the fixed 7-step loop is
+    // trivial for the compiler to unroll.
+    static constexpr uint64_t COLUMN_ORDER_PACKED =
+        uint64_t(3) | (uint64_t(2) << 8) | (uint64_t(4) << 16)
+                    | (uint64_t(1) << 24) | (uint64_t(5) << 32)
+                    | (uint64_t(0) << 40) | (uint64_t(6) << 48);
+
+    // column_order(i) - The i-th column to try (0 = most promising).
+    static constexpr int column_order(int i) {
+        return static_cast<int>((COLUMN_ORDER_PACKED >> (i * 8)) & 7);
+    }
 
 private:
     /**
      * negamax - The core recursive search algorithm with alpha-beta pruning.
-     * 
-     * @param pos   Current position (passed by value so we can modify it)
+     *
+     * @param pos   Current position, searched IN PLACE: each child move is
+     *              made on this object and unmade after its subtree
+     *              returns (see Position::unmake_move), so no Position is
+     *              ever copied during the search. The position is restored
+     *              exactly before negamax returns.
      * @param alpha Lower bound - best score we're guaranteed
      * @param beta  Upper bound - worst score opponent will allow
      * @return      Score from current player's perspective
      */
-    int negamax(Position pos, int alpha, int beta);
+    int negamax(Position& pos, int alpha, int beta);
 
     // Counter for positions analyzed
     unsigned long long node_count_ = 0;
 
-    // Transposition table for caching evaluated positions
-    TranspositionTable tt_;
+    // Transposition table for caching evaluated positions - either this
+    // solver's own (owns_tt_ == true) or one shared between solvers
+    TranspositionTable* tt_;
+    bool owns_tt_;
 };
 
 #endif // SOLVER_HPP
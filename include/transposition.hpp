@@ -26,46 +26,137 @@
  * 
  * TABLE STRUCTURE:
  * =============================================================================
- * 
- * We use a simple array of entries. Each entry stores:
- *   - key: The position's unique identifier
- *   - value: The alpha-beta score for this position
- * 
+ *
+ * The table is an array of CLUSTERS. A cluster is 16 bytes holding TWO
+ * packed entries for the same index:
+ *
+ *   deep   - kept only for positions near the ROOT of the search (few moves
+ *            played). These took the most work to compute, so they are the
+ *            most valuable to protect from being overwritten.
+ *   recent - always replaced. Catches the churn of leaf-adjacent positions.
+ *
+ * With one slot per index, a cheap near-leaf result could evict a result
+ * that cost millions of nodes to compute. Two slots with different
+ * replacement rules keep both kinds around, and since the cluster is a
+ * 16-byte aligned pair, probing both slots still costs a single cache line.
+ *
+ * Each entry is a SINGLE 64-bit word packing four pieces of information:
+ *
+ *   Bits 16-63: The high 48 bits of the position key (for verification)
+ *   Bits 10-15: Moves played at this position (the "depth" for replacement)
+ *   Bits 8-9:   The bound type (see Bound below)
+ *   Bits 0-7:   The stored score (an int8_t)
+ *
+ * Why pack? A naive struct of these fields takes 16 bytes after padding per
+ * entry. Packing halves that, which means twice as many entries fit in the
+ * CPU caches — and the table is probed on nearly every negamax node, so
+ * cache hits matter a lot.
+ *
+ * Dropping the low 16 key bits is safe in practice: the index already pins
+ * down the low bits of the key (index = key % size), so the stored high bits
+ * are enough to tell colliding positions apart.
+ *
+ * WHY STORE A BOUND TYPE?
+ * =============================================================================
+ *
+ * Alpha-beta search usually does NOT learn a position's exact score — a
+ * cutoff only proves the score is AT LEAST (or at most) some value. If we
+ * stored just the number, a future search couldn't tell which kind of fact
+ * it was. So each entry records what the value means:
+ *
+ *   EXACT - the true score of the position
+ *   LOWER - the true score is >= value (the search failed high / cut off)
+ *   UPPER - the true score is <= value (no move could beat alpha)
+ *
+ * The solver uses these to return early on EXACT hits and to narrow its
+ * [alpha, beta] window otherwise, which prunes far more of the tree.
+ *
  * We use key % table_size as the index. Collisions are handled by replacement
  * (newer entries overwrite older ones at the same index).
+ *
+ * THREAD SAFETY:
+ * =============================================================================
+ *
+ * One table may be shared by several solver threads (the root moves are
+ * analyzed in parallel). This is safe because each entry is a SINGLE
+ * 64-bit word that carries its own key bits: a reader either sees a
+ * whole entry written by somebody (and verifies its key) or it doesn't —
+ * there is no multi-word state to observe half-updated. put() and get()
+ * access the words with relaxed atomics so the sharing is well-defined;
+ * on x86-64 those compile to the exact same plain loads and stores as
+ * before. The worst a race can do is waste one store, never corrupt.
  */
 
 #ifndef TRANSPOSITION_HPP
 #define TRANSPOSITION_HPP
 
+#include <cstddef>
 #include <cstdint>
-#include <vector>
 
 class TranspositionTable {
 public:
+    /**
+     * Bound - What kind of fact the stored value represents.
+     * Fits in the 2 spare bits of the packed entry word.
+     */
+    enum Bound : uint8_t {
+        BOUND_EXACT = 0,  // value is the position's true score
+        BOUND_LOWER = 1,  // true score >= value (search cut off at beta)
+        BOUND_UPPER = 2   // true score <= value (nothing beat alpha)
+    };
+
     /**
      * Constructor - Creates a table with the given size.
      * 
-     * @param size  Number of entries (should be a power of 2 for efficiency)
+     * @param size  Number of entries. Rounded UP to the next power of two,
+     *              so that indexing can use a cheap bit-mask (see index()).
      *              Default is 8 million entries (~64 MB of memory)
      */
     explicit TranspositionTable(size_t size = 8388608);  // 2^23 = 8M entries
 
+    ~TranspositionTable();
+
+    // The table owns a large raw allocation - don't copy it around.
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
     /**
      * put - Store a position's value in the table.
-     * 
+     *
+     * The entry always lands in the cluster's "recent" slot; it also takes
+     * over the "deep" slot if it is at least as close to the root (fewer
+     * or equal moves played) as what's there.
+     *
      * @param key    Unique position key
      * @param value  The evaluated score
+     * @param bound  What the value means (exact score or a bound)
+     * @param moves  Moves played at this position (0..42); fewer moves =
+     *               more search below it = more worth keeping
      */
-    void put(uint64_t key, int8_t value);
+    void put(uint64_t key, int8_t value, Bound bound, int moves);
 
     /**
-     * get - Retrieve a position's value from the table.
-     * 
-     * @param key  Unique position key
-     * @return     The stored value, or 0 if not found
+     * get - Retrieve a position's entry from the table.
+     *
+     * @param key    Unique position key
+     * @param value  [out] The stored score, if found
+     * @param bound  [out] What the score means, if found
+     * @return       true if the position was found
      */
-    int8_t get(uint64_t key) const;
+    bool get(uint64_t key, int8_t& value, Bound& bound) const;
+
+    /**
+     * prefetch - Hint the CPU to start loading this key's entry NOW.
+     *
+     * The table is ~64 MB, so a probe almost always misses the cache and
+     * stalls for hundreds of cycles waiting on main memory. The solver can
+     * hide that latency by calling prefetch() as soon as it knows the key,
+     * then doing other useful work (win/draw checks) while the cache line
+     * travels. By the time get() runs, the data has usually arrived.
+     */
+    void prefetch(uint64_t key) const {
+        __builtin_prefetch(&table_[index(key)], 0, 0);
+    }
 
     /**
      * reset - Clear all entries (for starting a new game).
@@ -73,16 +164,60 @@ public:
     void reset();
 
 private:
-    struct Entry {
-        uint64_t key = 0;   // Position key (0 means empty)
-        int8_t value = 0;   // Stored score
+    /**
+     * Cluster - Two packed entries sharing one table index.
+     * 16 bytes, so four clusters fit in each 64-byte cache line and a
+     * probe of both slots never touches a second line.
+     */
+    // Kept trivial (no member initializers) so reset() may memset the
+    // whole array. alignas(16) + the 64-byte-aligned allocation below
+    // guarantee a cluster never straddles a cache-line boundary: four
+    // clusters tile each 64-byte line exactly, so probing both slots is
+    // always a single line load.
+    struct alignas(16) Cluster {
+        uint64_t deep;    // Replaced only by entries closer to the root
+        uint64_t recent;  // Always replaced
     };
+    static_assert(sizeof(Cluster) == 16, "Unexpected Cluster size");
+
+    /**
+     * pack - Combine key, value, bound, and move count into one 64-bit
+     * entry word (layout documented at the top of this file).
+     *
+     * An entry word of 0 means "empty slot" - a real key always has bits
+     * set above bit 15.
+     */
+    static uint64_t pack(uint64_t key, int8_t value, Bound bound, int moves) {
+        return (key & ~0xFFFFULL) | (uint64_t(moves) << 10)
+             | (uint64_t(bound) << 8) | static_cast<uint8_t>(value);
+    }
+
+    // matches - Does this entry word belong to this key?
+    static bool matches(uint64_t word, uint64_t key) {
+        return ((word ^ key) & ~0xFFFFULL) == 0;
+    }
 
-    std::vector<Entry> table_;
-    size_t size_;
+    // moves_of - Extract the stored move count from an entry word.
+    static int moves_of(uint64_t word) {
+        return static_cast<int>((word >> 10) & 0x3F);
+    }
 
-    // Helper to compute index from key
-    size_t index(uint64_t key) const { return key % size_; }
+    // Raw cache-line-aligned allocation (see constructor). A std::vector
+    // would only guarantee alignof(Cluster) = 16; aligning the base to 64
+    // keeps the four-clusters-per-line tiling exact.
+    Cluster* table_;
+    size_t size_;   // Entry capacity; always a power of two (see constructor)
+    size_t mask_;   // Cluster-count - 1, so (key & mask_) indexes a cluster
+
+    /**
+     * index - Map a key to a cluster.
+     *
+     * Because the cluster count is a power of two, the modulo is the same
+     * as `key & mask_` — but the AND is a single-cycle instruction, while
+     * a 64-bit division costs ~20 cycles. This runs on every probe and
+     * every store, so it's worth getting right.
+     */
+    size_t index(uint64_t key) const { return key & mask_; }
 };
 
 #endif // TRANSPOSITION_HPP
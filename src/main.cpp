@@ -25,41 +25,99 @@
 
 #include "position.hpp"
 #include "solver.hpp"
+#include "transposition.hpp"
+#include <cstdio>
+#include <cstring>
+#include <future>
 #include <iostream>
 #include <string>
-#include <sstream>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * all_valid_columns - Check that EVERY character of a move string is a
+ * column digit ('1'..'7'), eight characters at a time.
+ *
+ * SWAR (SIMD within a register): load 8 bytes into one uint64_t and
+ * range-check all of them with three arithmetic ops instead of eight
+ * compare-and-branch pairs. Per byte, c - '1' must land in 0..6:
+ *
+ *   - a byte BELOW '1' wraps around the subtraction and sets its high
+ *     bit (caught by `adj & HIGH`);
+ *   - a byte ABOVE '7' leaves adj >= 7, so adding 0x79 (= 0x80 - 7)
+ *     pushes it to 0x80+ (caught by `(adj + ...) & HIGH`).
+ *
+ * A carry between byte lanes can only happen when some byte is already
+ * invalid, so a valid string is never misjudged. Long move strings are
+ * the common case when game records are replayed in batch testing.
+ */
+static bool all_valid_columns(std::string_view moves) {
+    constexpr uint64_t ONES = 0x0101010101010101ULL;  // 1 in every byte
+    constexpr uint64_t HIGH = 0x8080808080808080ULL;  // each byte's top bit
+
+    size_t i = 0;
+    for (; i + 8 <= moves.size(); i += 8) {
+        uint64_t w;
+        std::memcpy(&w, moves.data() + i, 8);  // safe unaligned load
+        uint64_t adj = w - 0x31 * ONES;        // per-byte c - '1'
+        if (((adj + 0x79 * ONES) | adj) & HIGH) {
+            return false;
+        }
+    }
+
+    // Scalar check for the up-to-7 leftover characters
+    for (; i < moves.size(); i++) {
+        if (static_cast<unsigned>(moves[i] - '1') >= 7u) {
+            return false;
+        }
+    }
+    return true;
+}
 
 /**
  * parse_moves - Parse a move string and apply moves to a position.
- * 
+ *
  * @param pos       The Position object to modify
  * @param moves     A string like "4433221" where each digit is a column (1-7)
  * @return          Number of moves successfully parsed, or -1 if invalid
  */
-int parse_moves(Position& pos, const std::string& moves) {
+int parse_moves(Position& pos, std::string_view moves) {
+    // Validate all the digits up front (8 at a time - see above), so the
+    // apply loop below runs without a per-character range branch. Only on
+    // failure do we rescan to name the offending character.
+    if (__builtin_expect(!all_valid_columns(moves), 0)) {
+        for (char c : moves) {
+            // The subtraction wraps anything below '1' around to a huge
+            // unsigned number, so ONE comparison covers both "too low"
+            // and "too high" — half the branches of (c < '1' || c > '7').
+            if (static_cast<unsigned>(c - '1') >= 7u) {
+                std::cerr << "Error: Invalid character '" << c
+                          << "' in move string\n";
+                break;
+            }
+        }
+        return -1;
+    }
+
     int count = 0;
-    
+
     for (char c : moves) {
-        // Check if character is a valid column digit (1-7)
-        if (c < '1' || c > '7') {
-            std::cerr << "Error: Invalid character '" << c << "' in move string\n";
-            return -1;
-        }
-        
-        // Convert '1'-'7' to 0-6 (C++ uses 0-indexed arrays)
-        int col = c - '1';
-        
-        // Check if column is playable
-        if (!pos.can_play(col)) {
+        unsigned col = static_cast<unsigned>(c - '1');
+
+        // Check if column is playable. A full column is the rare error
+        // case, so tell the compiler to lay out the loop for the common
+        // path (__builtin_expect keeps the error code out of the way).
+        if (__builtin_expect(!pos.can_play(col), 0)) {
             std::cerr << "Error: Column " << (col + 1) << " is full\n";
             return -1;
         }
-        
+
         // Make the move
         pos.make_move(col);
         count++;
     }
-    
+
     return count;
 }
 
@@ -68,7 +126,7 @@ int parse_moves(Position& pos, const std::string& moves) {
  * 
  * Resets the board and replays the given moves.
  */
-void handle_position(Position& pos, const std::string& args) {
+void handle_position(Position& pos, std::string_view args) {
     // Reset to empty position
     pos = Position();
     
@@ -89,42 +147,71 @@ void handle_position(Position& pos, const std::string& args) {
  * Uses the Negamax solver to find the best move!
  */
 void handle_go(Position& pos) {
-    // Check for immediate wins first (fast path)
-    for (int col = 0; col < Position::WIDTH; col++) {
-        if (pos.can_play(col) && pos.is_winning_move(col)) {
-            std::cout << "bestmove " << (col + 1) << " score WIN (immediate)\n";
-            return;
-        }
+    // Check for immediate wins first (fast path).
+    // winning_moves() computes every instantly-winning square as one
+    // bitboard, so a single test replaces seven per-column checks.
+    uint64_t wins = pos.winning_moves();
+    if (wins) {
+        int col = __builtin_ctzll(wins) / 7;  // bit index -> column
+        std::cout << "bestmove " << (col + 1) << " score WIN (immediate)\n";
+        return;
     }
-    
+
     // Check if game is already over
     if (pos.nb_moves() == Position::WIDTH * Position::HEIGHT) {
         std::cout << "Game is a draw - no moves available\n";
         return;
     }
 
-    // Use the solver to find the best move
-    Solver solver;
     int best_col = -1;
     int best_score = -1000;
+    unsigned long long total_nodes = 0;
 
     std::cout << "Analyzing...\n";
 
-    for (int col = 0; col < Position::WIDTH; col++) {
-        if (pos.can_play(col)) {
-            // Try this move
-            Position next = pos;
-            next.make_move(col);
+    // The root moves are independent searches, so analyze them in
+    // PARALLEL: one async task per playable column. On a typical
+    // multi-core machine this cuts wall-clock analysis time by roughly
+    // the number of playable columns.
+    //
+    // All tasks SHARE one transposition table (safe - see
+    // transposition.hpp): the root subtrees transpose into each other
+    // heavily, so each thread prunes on positions its siblings already
+    // solved. The table is static so later "go" commands also reuse
+    // everything solved earlier - entries are keyed by position alone,
+    // so they never go stale when the game moves on.
+    static TranspositionTable shared_tt;
+
+    // Iterate the set bits of the playable-moves bitboard: each pass
+    // handles the lowest remaining bit and then clears it (bb &= bb - 1).
+    std::vector<std::pair<int, std::future<std::pair<int, unsigned long long>>>>
+        tasks;
+
+    for (uint64_t bb = pos.playable_moves(); bb; bb &= bb - 1) {
+        int col = __builtin_ctzll(bb) / 7;  // bit index -> column
+
+        // Try this move
+        Position next = pos;
+        next.make_move(col);
 
-            // Get the score (negate because we're looking from opponent's view)
+        tasks.emplace_back(col, std::async(std::launch::async, [next] {
+            Solver solver(shared_tt);
+            // Negate because we're looking from the opponent's view
             int score = -solver.solve(next);
+            return std::make_pair(score, solver.get_node_count());
+        }));
+    }
 
-            std::cout << "  Column " << (col + 1) << ": score " << score << "\n";
+    // Collect the results (in column order, since that's launch order)
+    for (auto& [col, fut] : tasks) {
+        auto [score, nodes] = fut.get();
+        total_nodes += nodes;
 
-            if (score > best_score) {
-                best_score = score;
-                best_col = col;
-            }
+        std::cout << "  Column " << (col + 1) << ": score " << score << "\n";
+
+        if (score > best_score) {
+            best_score = score;
+            best_col = col;
         }
     }
 
@@ -136,36 +223,84 @@ void handle_go(Position& pos) {
 
     std::cout << "bestmove " << (best_col + 1) << " score " << best_score 
               << " (" << result << ")\n";
-    std::cout << "Nodes analyzed: " << solver.get_node_count() << "\n";
+    std::cout << "Nodes analyzed: " << total_nodes << "\n";
+}
+
+/**
+ * check_cpu_features - Fail gracefully on CPUs missing required instructions.
+ *
+ * position.hpp compiles the hot bitboard code with
+ * `#pragma GCC target("popcnt,bmi,bmi2")`, so on a pre-Haswell x86-64
+ * machine the engine would die mid-search with an illegal-instruction
+ * fault. One CPUID check at startup turns that crash into a readable
+ * error message. (Non-x86 and non-GCC builds never emit those
+ * instructions, so there is nothing to check.)
+ */
+static bool check_cpu_features() {
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)
+    if (!__builtin_cpu_supports("popcnt") || !__builtin_cpu_supports("bmi") ||
+        !__builtin_cpu_supports("bmi2")) {
+        std::cerr << "Error: this build requires a CPU with POPCNT, BMI1 and "
+                     "BMI2 (Intel Haswell / AMD Excavator or newer).\n";
+        return false;
+    }
+#endif
+    return true;
 }
 
 /**
  * main - Main command loop.
  */
 int main() {
+    if (!check_cpu_features()) {
+        return 1;
+    }
+
     std::cout << "Marlin Connect 4 Engine v0.1\n";
     std::cout << "Type 'help' for available commands.\n\n";
     
     Position pos;
-    std::string line;
-    
+
+    // One fixed input buffer reused for every command. fgets writes
+    // straight into it and the string_views below just point into it, so
+    // the command loop never touches the heap - it matters when thousands
+    // of "position ... / go" pairs are piped in for batch testing.
+    // (4 KB is far beyond any valid command: the longest is "position "
+    // plus at most 42 move digits.)
+    char line[4096];
+
     while (true) {
-        std::cout << "> ";
-        
+        // cout is no longer tied to an input stream (we read with fgets),
+        // so flush the prompt explicitly.
+        std::cout << "> " << std::flush;
+
         // Read a line from stdin
-        if (!std::getline(std::cin, line)) {
+        if (!std::fgets(line, sizeof line, stdin)) {
             break;  // EOF or error
         }
-        
-        // Parse the command and arguments
-        std::istringstream iss(line);
-        std::string command;
-        iss >> command;
-        
-        // Get remaining arguments (if any)
-        std::string args;
-        std::getline(iss >> std::ws, args);  // Skip whitespace, get rest
-        
+
+        // Parse the command and arguments by slicing the line at the first
+        // space. string_view just points into `line` - no stringstream, no
+        // per-command heap allocation.
+        std::string_view view(line);
+
+        // Strip the trailing newline fgets keeps (and a CR, if the input
+        // came from a Windows-style file)
+        while (!view.empty() && (view.back() == '\n' || view.back() == '\r')) {
+            view.remove_suffix(1);
+        }
+        size_t space = view.find(' ');
+        std::string_view command = view.substr(0, space);
+
+        // Get remaining arguments (if any), skipping the spaces in between
+        std::string_view args;
+        if (space != std::string_view::npos) {
+            args = view.substr(space + 1);
+            while (!args.empty() && args.front() == ' ') {
+                args.remove_prefix(1);
+            }
+        }
+
         // Handle commands
         if (command == "quit" || command == "exit") {
             std::cout << "Goodbye!\n";
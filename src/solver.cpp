@@ -3,27 +3,84 @@
  */
 
 #include "solver.hpp"
+#include "opening_book.hpp"
 
-// Define the static member (required for linking)
-constexpr int Solver::COLUMN_ORDER[7];
+#include <algorithm>
+
+namespace {
+// Total cells on the board - the base of every score formula. Hoisted to
+// namespace scope so the compiler sees one visible constant instead of
+// re-deriving WIDTH * HEIGHT at each use site.
+constexpr int CELLS = Position::WIDTH * Position::HEIGHT;
+}  // namespace
 
 /**
  * solve - Public entry point for the solver.
- * 
- * We initialize alpha to the worst possible score (we're losing as fast as possible)
- * and beta to the best possible score (we're winning as fast as possible).
- * These bounds will tighten as we explore the game tree.
+ *
+ * Instead of one negamax call with the full window, we binary-search the
+ * score with NULL-WINDOW probes (windows of width 1).
+ *
+ * Why is that faster? A null-window search can't distinguish scores - it
+ * only answers "is the true score above med or not?" - but that question
+ * prunes enormously more of the tree than a wide window does, because
+ * every node cuts off at the slightest excuse. Each probe also fills the
+ * transposition table with bounds that accelerate the following probes.
+ * A dozen cheap yes/no searches end up far cheaper than one exact search.
  */
 int Solver::solve(const Position& pos) {
     reset_node_count();
-    
-    // Initial bounds:
-    // alpha = can't be worse than losing on the very last possible move
-    // beta = can't be better than winning on the next move
-    int alpha = -(Position::WIDTH * Position::HEIGHT) / 2;
-    int beta = (Position::WIDTH * Position::HEIGHT + 1) / 2;
-    
-    return negamax(pos, alpha, beta);
+
+    // -------------------------------------------------------------------------
+    // OPENING BOOK LOOKUP
+    // -------------------------------------------------------------------------
+    // Early positions are by far the most expensive to search, but there
+    // are few enough of them that their exact scores can be precomputed
+    // offline (tools/generate_book) and embedded in the binary. A binary
+    // search of the sorted table replaces the whole search on a hit.
+    if (pos.nb_moves() <= opening_book::MAX_PLIES) {
+        uint64_t book_key = pos.canonical_key();
+        const opening_book::Entry* end = opening_book::BOOK + opening_book::SIZE;
+        const opening_book::Entry* it = std::lower_bound(
+            opening_book::BOOK, end, book_key,
+            [](const opening_book::Entry& e, uint64_t k) { return e.key < k; });
+        if (it != end && it->key == book_key) {
+            return it->score;
+        }
+    }
+
+    // One mutable copy for the whole solve: negamax searches it in place
+    // (make/unmake) and always hands it back unchanged.
+    Position root = pos;
+
+    // The score is bracketed by [min, max]:
+    // min = losing on the very last possible move
+    // max = winning with our very next move
+    int min = -(CELLS - pos.nb_moves()) / 2;
+    int max = (CELLS + 1 - pos.nb_moves()) / 2;
+
+    // Binary search: each null-window probe at `med` tells us which half
+    // of the bracket the true score lies in.
+    while (min < max) {
+        int med = min + (max - min) / 2;
+
+        // Nudge the probe toward zero: most positions score near a draw,
+        // so testing close to 0 first usually halves the bracket on the
+        // cheap side. (Careful integer division - min is negative here.)
+        if (med <= 0 && min / 2 < med) {
+            med = min / 2;
+        } else if (med >= 0 && max / 2 > med) {
+            med = max / 2;
+        }
+
+        int r = negamax(root, med, med + 1);
+        if (r <= med) {
+            max = r;  // Failed low: true score <= med (and <= r)
+        } else {
+            min = r;  // Failed high: true score >= med+1 (and >= r)
+        }
+    }
+
+    return min;
 }
 
 /**
@@ -34,43 +91,66 @@ int Solver::solve(const Position& pos) {
  * If so, we can use the cached value to narrow our bounds.
  * At the end, we store the result for future lookups.
  */
-int Solver::negamax(Position pos, int alpha, int beta) {
+int Solver::negamax(Position& pos, int alpha, int beta) {
     node_count_++;
 
+    // Every score formula below needs the move count; compute the popcount
+    // once instead of re-asking pos.nb_moves() at each use.
+    const int nm = pos.nb_moves();
+
+    // -------------------------------------------------------------------------
+    // START THE TT LOAD EARLY (prefetch)
+    // -------------------------------------------------------------------------
+    // Compute the key now and ask the CPU to begin fetching the table entry.
+    // The win/draw checks below give the load a few hundred cycles to
+    // complete, so the actual tt_->get() further down rarely stalls.
+    // canonical_key() folds mirror-image positions onto one entry, so a
+    // solved subtree also answers its left/right reflection.
+    uint64_t key = pos.canonical_key();
+    tt_->prefetch(key);
+
     // -------------------------------------------------------------------------
     // BASE CASE 1: Check if current player can win immediately
     // -------------------------------------------------------------------------
-    for (int i = 0; i < Position::WIDTH; i++) {
-        int col = COLUMN_ORDER[i];  // Check center columns first
-        if (pos.can_play(col) && pos.is_winning_move(col)) {
-            // Current player wins! Score based on how fast we win.
-            return (Position::WIDTH * Position::HEIGHT + 1 - pos.nb_moves()) / 2;
-        }
+    // winning_moves() walks the playable-squares bitboard bit by bit
+    // (clearing the lowest set bit each pass), so this is one call instead
+    // of seven can_play/is_winning_move pairs. The score only depends on
+    // how fast we win, not which column does it, so any non-zero result
+    // is enough.
+    if (pos.winning_moves()) {
+        return (CELLS + 1 - nm) / 2;
     }
 
     // -------------------------------------------------------------------------
     // BASE CASE 2: Check for draw (no moves left = all 42 cells filled)
     // -------------------------------------------------------------------------
-    if (pos.nb_moves() >= Position::WIDTH * Position::HEIGHT - 1) {
+    if (nm >= CELLS - 1) {
         return 0;  // Draw (or about to be)
     }
 
     // -------------------------------------------------------------------------
     // TRANSPOSITION TABLE LOOKUP
     // -------------------------------------------------------------------------
-    // Check if we've seen this position before. If the cached value gives us
-    // useful information, we can narrow our search bounds or return early.
-    uint64_t key = pos.key();
-    int8_t cached_value = tt_.get(key);
-    
-    if (cached_value != 0) {
-        // We found a cached upper bound for this position
-        // The cached value is an upper bound on the true score
-        int max_from_cache = cached_value + Position::WIDTH * Position::HEIGHT / 2 - 1;
-        if (beta > max_from_cache) {
-            beta = max_from_cache;
-            if (alpha >= beta) return beta;  // Prune with cached info!
+    // Check if we've seen this position before. The entry tells us not just
+    // a number but what KIND of fact it is (exact score / lower / upper
+    // bound), so we can return immediately or narrow our search window.
+    // (The key was computed and the entry prefetched at the top of negamax.)
+    int8_t cached_value;
+    TranspositionTable::Bound cached_bound;
+
+    if (tt_->get(key, cached_value, cached_bound)) {
+        int v = cached_value;
+        switch (cached_bound) {
+            case TranspositionTable::BOUND_EXACT:
+                return v;  // We know the true score - done!
+            case TranspositionTable::BOUND_LOWER:
+                if (v > alpha) alpha = v;  // True score is at least v
+                break;
+            case TranspositionTable::BOUND_UPPER:
+                if (v < beta) beta = v;    // True score is at most v
+                break;
         }
+        if (alpha >= beta) return v;  // The cached bound alone prunes us!
     }
 
     // -------------------------------------------------------------------------
@@ -78,7 +158,7 @@ int Solver::negamax(Position pos, int alpha, int beta) {
     // -------------------------------------------------------------------------
     // We can't do better than winning in 2 moves (since we already checked
     // for immediate wins above). This helps prune more branches.
-    int max_possible = (Position::WIDTH * Position::HEIGHT - 1 - pos.nb_moves()) / 2;
+    int max_possible = (CELLS - 1 - nm) / 2;
     if (beta > max_possible) {
         beta = max_possible;
         if (alpha >= beta) return beta;  // Prune!
@@ -87,22 +167,106 @@ int Solver::negamax(Position pos, int alpha, int beta) {
     // -------------------------------------------------------------------------
     // RECURSIVE CASE: Try all moves with alpha-beta pruning
     // -------------------------------------------------------------------------
+    // Remember the window's starting point so we can classify the result
+    // (exact score vs. upper bound) when we store it in the TT below.
+    const int alpha_orig = alpha;
+
+    // Compute ALL landing squares with one add (see playable_moves) and
+    // test each column against that shared bitboard, instead of asking
+    // can_play() seven separate times.
+    uint64_t possible = pos.playable_moves();
+
+    // ---------------------------------------------------------------------
+    // PRUNE PROVABLY LOSING MOVES
+    // ---------------------------------------------------------------------
+    // Look at where the OPPONENT could win next turn. Three free facts:
+    //
+    //  1. If they have two or more winning squares we can play into, we
+    //     can only block one - this position is lost RIGHT NOW, no search
+    //     needed.
+    //  2. If they have exactly one, every move except the block loses, so
+    //     only the block is worth searching.
+    //  3. A move landing directly BELOW an opponent winning square hands
+    //     them the win on top of it - never search those.
+    //
+    // All of this costs one threat-mask computation and a few bit ops,
+    // and it deletes whole subtrees that alpha-beta would otherwise have
+    // to refute move by move.
+    const uint64_t opponent_win = Position::compute_winning_positions(
+        pos.get_position() ^ pos.get_mask(), pos.get_mask());
+
+    const uint64_t forced = possible & opponent_win;
+    if (forced) {
+        if (forced & (forced - 1)) {
+            // Two or more immediate threats: we lose after our next move
+            return -(CELLS - nm) / 2;
+        }
+        possible = forced;  // Exactly one threat: blocking is forced
+    }
+
+    // Never play directly under an opponent's winning square
+    possible &= ~(opponent_win >> 1);
+    if (!possible) {
+        // Every remaining move gifts the opponent the game
+        return -(CELLS - nm) / 2;
+    }
+
+    // ---------------------------------------------------------------------
+    // MOVE ORDERING: most threatening moves first
+    // ---------------------------------------------------------------------
+    // Alpha-beta prunes best when the strongest move is searched first.
+    // For each legal move we count (one popcount) how many winning squares
+    // the move would give us, and insertion-sort the columns by that count.
+    // Scoring all seven moves costs a few dozen ALU ops - nothing next to
+    // the subtrees a first-move cutoff saves. Ties keep the center-first
+    // COLUMN_ORDER, which the stable insertion preserves.
+    int order[Position::WIDTH];   // Columns, best threat count first
+    int threats[Position::WIDTH]; // Their threat counts (sorted along)
+    int n_moves = 0;
+
     for (int i = 0; i < Position::WIDTH; i++) {
-        int col = COLUMN_ORDER[i];  // Try center columns first (move ordering)
-        
-        if (pos.can_play(col)) {
-            // Create a copy and make the move
-            Position next = pos;
-            next.make_move(col);
+        int col = column_order(i);  // Visit in center-first order
+        uint64_t move = possible & Position::column_mask(col);
+        if (!move) continue;
+
+        int t = __builtin_popcountll(Position::compute_winning_positions(
+            pos.get_position() | move, pos.get_mask() | move));
+
+        int j = n_moves++;
+        while (j > 0 && threats[j - 1] < t) {
+            order[j] = order[j - 1];
+            threats[j] = threats[j - 1];
+            --j;
+        }
+        order[j] = col;
+        threats[j] = t;
+    }
+
+    // Save the two state words once; every child restores from them.
+    // Make/unmake on the single Position replaces a struct copy per child
+    // and keeps the state hot in registers.
+    const uint64_t saved_mask = pos.get_mask();
+    const uint64_t saved_position = pos.get_position();
+
+    for (int i = 0; i < n_moves; i++) {
+        int col = order[i];
+
+        {
+            pos.make_move(col);
 
             // Recursively evaluate from opponent's perspective
             // Note: We negate and swap alpha/beta bounds
-            int score = -negamax(next, -beta, -alpha);
+            int score = -negamax(pos, -beta, -alpha);
+
+            pos.unmake_move(saved_mask, saved_position);
 
             // ALPHA-BETA PRUNING CHECK
             if (score >= beta) {
-                // This move is "too good" - opponent won't allow this line
-                // We can stop searching this branch entirely!
+                // This move is "too good" - opponent won't allow this line.
+                // We only proved the score is AT LEAST this much, so record
+                // it as a LOWER bound before cutting off.
+                tt_->put(key, static_cast<int8_t>(score),
+                        TranspositionTable::BOUND_LOWER, nm);
                 return score;  // Fail-high (beta cutoff)
             }
 
@@ -116,9 +280,13 @@ int Solver::negamax(Position pos, int alpha, int beta) {
     // -------------------------------------------------------------------------
     // TRANSPOSITION TABLE STORE
     // -------------------------------------------------------------------------
-    // Store the result. We convert alpha to a relative value.
-    // This helps future searches prune earlier.
-    tt_.put(key, static_cast<int8_t>(alpha - Position::WIDTH * Position::HEIGHT / 2 + 1));
+    // If some move raised alpha, the window never failed high, so alpha is
+    // the position's EXACT score. If nothing beat the original alpha, we
+    // only learned the score is at most alpha — an UPPER bound.
+    tt_->put(key, static_cast<int8_t>(alpha),
+            alpha > alpha_orig ? TranspositionTable::BOUND_EXACT
+                               : TranspositionTable::BOUND_UPPER,
+            nm);
 
     return alpha;
 }
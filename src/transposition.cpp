@@ -4,27 +4,98 @@
 
 #include "transposition.hpp"
 
-TranspositionTable::TranspositionTable(size_t size) : size_(size) {
-    table_.resize(size);
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+TranspositionTable::TranspositionTable(size_t size) {
+    // Round up to the next power of two so index() can use a bit-mask
+    // instead of an expensive modulo. The default (2^23 entries) is
+    // unchanged: with two entries per cluster, that's 2^22 clusters and
+    // the same 64 MB of memory as before.
+    // (Minimum of 8 entries = 4 clusters = exactly one cache line.)
+    size_ = 8;
+    while (size_ < size) {
+        size_ <<= 1;
+    }
+    mask_ = size_ / 2 - 1;
+
+    const size_t bytes = (mask_ + 1) * sizeof(Cluster);
+
+#if defined(__linux__)
+    // Probes index the table by hashed key, i.e. randomly. On 4 KiB pages
+    // the default 64 MB table needs 16384 TLB entries — far more than the
+    // DTLB holds — so nearly every probe also pays a page-walk. Aligning
+    // the allocation to 2 MiB and asking for transparent huge pages cuts
+    // that to 32 entries, which the TLB covers easily. (madvise is only a
+    // hint; if the kernel declines we just keep 4 KiB pages.)
+    void* raw = nullptr;
+    if (posix_memalign(&raw, 2 * 1024 * 1024, bytes) != 0) {
+        raw = std::aligned_alloc(64, bytes);
+    } else {
+        madvise(raw, bytes, MADV_HUGEPAGE);
+    }
+    table_ = static_cast<Cluster*>(raw);
+#else
+    // Elsewhere, just keep the cache-line alignment. The byte count is
+    // always a multiple of 64 for any non-tiny table, which aligned_alloc
+    // requires.
+    table_ = static_cast<Cluster*>(std::aligned_alloc(64, bytes));
+#endif
+    reset();
+}
+
+TranspositionTable::~TranspositionTable() {
+    std::free(table_);
 }
 
-void TranspositionTable::put(uint64_t key, int8_t value) {
-    size_t idx = index(key);
-    table_[idx].key = key;
-    table_[idx].value = value;
+void TranspositionTable::put(uint64_t key, int8_t value, Bound bound,
+                             int moves) {
+    Cluster& cluster = table_[index(key)];
+    uint64_t word = pack(key, value, bound, moves);
+
+    // Relaxed atomics make concurrent access from the parallel root
+    // searches well-defined (see the thread-safety note in the header).
+    // On x86-64 they compile to the same single MOVs as plain accesses.
+
+    // The "recent" slot is always overwritten - it catches the heavy
+    // churn of positions near the leaves.
+    __atomic_store_n(&cluster.recent, word, __ATOMIC_RELAXED);
+
+    // The "deep" slot is reserved for positions at least as close to the
+    // root as its current occupant: those results cost the most search
+    // work, so they're the most valuable to keep. (An empty slot - word
+    // 0 - is always claimed.)
+    uint64_t deep = __atomic_load_n(&cluster.deep, __ATOMIC_RELAXED);
+    if (deep == 0 || moves <= moves_of(deep)) {
+        __atomic_store_n(&cluster.deep, word, __ATOMIC_RELAXED);
+    }
 }
 
-int8_t TranspositionTable::get(uint64_t key) const {
-    size_t idx = index(key);
-    if (table_[idx].key == key) {
-        return table_[idx].value;
+bool TranspositionTable::get(uint64_t key, int8_t& value, Bound& bound) const {
+    // Both slots share a 16-byte cluster, so checking the second slot is
+    // free once the cache line is loaded. Try the long-lived slot first.
+    const Cluster& cluster = table_[index(key)];
+
+    uint64_t word = __atomic_load_n(&cluster.deep, __ATOMIC_RELAXED);
+    if (!matches(word, key)) {
+        word = __atomic_load_n(&cluster.recent, __ATOMIC_RELAXED);
+        if (!matches(word, key)) {
+            return false;  // Empty slots or a different position
+        }
     }
-    return 0;  // Not found (0 indicates unknown, which is also a draw score)
+    value = static_cast<int8_t>(word & 0xFF);
+    bound = static_cast<Bound>((word >> 8) & 0x3);
+    return true;
 }
 
 void TranspositionTable::reset() {
-    for (auto& entry : table_) {
-        entry.key = 0;
-        entry.value = 0;
-    }
+    // Clusters are plain packed words, so one big memset is the fastest
+    // way to clear 64 MB: the library routine uses wide (rep stos / SIMD)
+    // stores and saturates memory bandwidth, where a per-field loop would
+    // issue two narrow stores per cluster.
+    std::memset(table_, 0, (mask_ + 1) * sizeof(Cluster));
 }
@@ -13,8 +13,88 @@
  */
 
 #include "position.hpp"
+#include <array>
 #include <cassert>   // For assert()
-#include <iostream>
+#include <cstdio>
+
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)
+#include <immintrin.h>  // _pext_u64 for the BMI2 vertical-win cross-check
+#define MARLIN_TEST_HAVE_PEXT 1
+#endif
+
+// ============================================================================
+// TEST LOGGING
+// ============================================================================
+//
+// The progress prints cost far more than the bit operations under test
+// (stream synchronization, locale), which muddies any timing comparison
+// run on this binary. LOG() writes through fprintf to stderr instead of
+// cout, and compiling with -DMARLIN_QUIET_TESTS turns every print into
+// nothing at all - the `if constexpr` discards the call at compile time,
+// leaving only the assertions.
+#ifdef MARLIN_QUIET_TESTS
+constexpr bool kQuiet = true;
+#else
+constexpr bool kQuiet = false;
+#endif
+
+#define LOG(...)                                   \
+    do {                                           \
+        if constexpr (!kQuiet) {                   \
+            std::fprintf(stderr, __VA_ARGS__);     \
+        }                                          \
+    } while (0)
+
+// ============================================================================
+// PERF_CHECK - loop-body checks that vanish in profiling builds
+// ============================================================================
+//
+// When this binary is used to profile Position's hot ops (built with
+// -DPERF_BUILD -DNDEBUG -DMARLIN_QUIET_TESTS), a plain assert() in a
+// tight loop still perturbs the measurement: even as a no-op it blocks
+// some inlining, and with asserts on, the conditional __assert_fail
+// call sits in the loop being timed. PERF_CHECK tells the optimizer the
+// condition HOLDS (the false branch is unreachable), so e.g. the
+// can_play loop compiles to the same straight-line code the solver
+// sees. Outside perf builds it is exactly assert().
+#ifdef PERF_BUILD
+#define PERF_CHECK(x)                        \
+    do {                                     \
+        if (!(x)) __builtin_unreachable();   \
+    } while (0)
+#else
+#define PERF_CHECK(x) assert(x)
+#endif
+
+// ============================================================================
+// COMPILE-TIME SCENARIOS
+// ============================================================================
+//
+// Position is pure bit arithmetic and fully constexpr, so whole
+// scenarios can run DURING COMPILATION: play() replays a move string in
+// a constexpr context and the static_asserts pin down the results. They
+// cost nothing at runtime - a regression here fails the build itself.
+static constexpr Position play(const char* moves) {
+    Position pos;
+    for (; *moves; moves++) {
+        pos.make_move(*moves - '1');
+    }
+    return pos;
+}
+
+static_assert(play("").nb_moves() == 0,
+              "empty board has no moves");
+static_assert(play("121212").is_winning_move(0),
+              "three-stone stack wins vertically in column 1");
+static_assert(!play("121212").is_winning_move(2),
+              "column 3 is no winning move in the vertical scenario");
+static_assert(play("112233").winning_moves() ==
+                  (Position::column_mask(3) & play("112233").playable_moves()),
+              "bottom-row run wins horizontally in exactly column 4");
+static_assert(!play("444444").can_play(3),
+              "six stones fill a column");
+static_assert(play("12").canonical_key() == play("76").canonical_key(),
+              "mirror-image positions share a canonical key");
 
 // ============================================================================
 // TEST 1: Constructor creates empty board
@@ -27,7 +107,7 @@ void test_constructor() {
     assert(pos.get_position() == 0);
     assert(pos.nb_moves() == 0);
     
-    std::cout << "✓ test_constructor passed\n";
+    LOG("✓ test_constructor passed\n");
 }
 
 // ============================================================================
@@ -37,21 +117,21 @@ void test_can_play() {
     Position pos;
     
     // All columns should be playable on empty board
+    // (PERF_CHECK: plain assert outside perf builds - see above)
     for (int col = 0; col < Position::WIDTH; col++) {
-        assert(pos.can_play(col) == true);
+        PERF_CHECK(pos.can_play(col));
     }
     
-    // Fill up column 0 (6 moves)
-    for (int i = 0; i < Position::HEIGHT; i++) {
-        pos.make_move(0);
-    }
+    // Fill up column 0 in one operation (test-only bulk helper; the
+    // make_move path is covered by the other tests)
+    pos.fill_column_debug(0);
     
     // Column 0 should now be full, others still playable
-    assert(pos.can_play(0) == false);
-    assert(pos.can_play(1) == true);
-    assert(pos.can_play(3) == true);
+    assert(!pos.can_play(0));
+    assert(pos.can_play(1));
+    assert(pos.can_play(3));
     
-    std::cout << "✓ test_can_play passed\n";
+    LOG("✓ test_can_play passed\n");
 }
 
 // ============================================================================
@@ -73,97 +153,211 @@ void test_make_move() {
     // bit 0 = row 0, bit 1 = row 1
     assert((pos.get_mask() & 0b11) == 0b11);
     
-    std::cout << "✓ test_make_move passed\n";
+    LOG("✓ test_make_move passed\n");
 }
 
 // ============================================================================
-// TEST 4: Vertical win detection
+// TEST 4: Win detection (table-driven)
 // ============================================================================
-void test_vertical_win() {
-    Position pos;
-    
-    // Player 1 plays: 0, Player 2 plays: 1 (alternating)
-    // Build a vertical stack in column 0 for Player 1
-    pos.make_move(0);  // P1 at (0,0)
-    pos.make_move(1);  // P2 at (0,1)
-    pos.make_move(0);  // P1 at (1,0)
-    pos.make_move(1);  // P2 at (1,1)
-    pos.make_move(0);  // P1 at (2,0)
-    pos.make_move(1);  // P2 at (2,1)
-    
-    // P1 can win with one more in column 0
-    assert(pos.is_winning_move(0) == true);
-    
-    // Other columns should not be winning moves
-    assert(pos.is_winning_move(2) == false);
-    assert(pos.is_winning_move(3) == false);
-    
-    std::cout << "✓ test_vertical_win passed\n";
+//
+// Every win-detection scenario has the same shape: replay a move
+// sequence, then check WHICH columns win for the player to move. So
+// instead of one hand-rolled function per direction, the scenarios are
+// data - a move string (same '1'..'7' format the CLI uses) plus the
+// expected set of winning columns - and ONE loop replays and checks
+// them all against the batched winning_moves() bitboard. Adding a
+// scenario is now a one-line table entry.
+struct WinCase {
+    const char* name;   // Shown when the case runs
+    const char* moves;  // Move string, digits '1'..'7' (as in the CLI)
+    uint8_t win_cols;   // Expected winning columns; bit c = column c
+};
+
+static constexpr WinCase WIN_CASES[] = {
+    // Vertical: P1 stacks three in column 1, P2 in column 2.
+    // P1 completes the stack by playing column 1 again.
+    {"vertical_win", "121212", 0b0000001},
+
+    // Horizontal: P1 owns the bottom of columns 1-3 (P2 stacked on
+    // top each time). P1 completes the row with column 4.
+    {"horizontal_win", "112233", 0b0001000},
+
+    // Diagonal /: P1 builds (0,0), (1,1), (2,2) with P2's replies
+    // filling column 4 up to row 2, so column 4 lands on (3,3) and
+    // completes the diagonal.
+    {"diagonal_win", "1223433474", 0b0001000},
+
+    // No win available for either side after two quiet moves
+    {"no_win", "12", 0b0000000},
+};
+
+// winning_cols - Collapse winning_moves() to a per-column bitmask.
+static uint8_t winning_cols(const Position& pos) {
+    uint64_t wins = pos.winning_moves();
+    uint8_t cols = 0;
+    for (int col = 0; col < Position::WIDTH; col++) {
+        if (wins & Position::column_mask(col)) {
+            cols = static_cast<uint8_t>(cols | (1u << col));
+        }
+    }
+    return cols;
+}
+
+#ifdef MARLIN_TEST_HAVE_PEXT
+// vertical_win_cols_pext - Vertical wins only, via BMI2 PEXT.
+//
+// An alternative formulation of the vertical case: PEXT compresses a
+// column's six cells into the low bits of a byte (one instruction,
+// where a portable extract needs shift+mask per column), the landing
+// slot is the lowest clear bit of the compressed fill, and four-in-a-row
+// is the classic and-of-shifts on the byte. The suite uses it as an
+// independent cross-check against the batched winning_moves() mask -
+// two different computations agreeing on every case catches a bug in
+// either one.
+static uint8_t vertical_win_cols_pext(const Position& pos) {
+    uint8_t cols = 0;
+    for (int col = 0; col < Position::WIDTH; col++) {
+        unsigned stones = static_cast<unsigned>(
+            _pext_u64(pos.get_position(), Position::column_mask(col)));
+        unsigned filled = static_cast<unsigned>(
+            _pext_u64(pos.get_mask(), Position::column_mask(col)));
+
+        // Landing slot: the lowest clear bit of the column fill
+        // (zero when the column is full)
+        unsigned landing = ~filled & (filled + 1) & 0x3F;
+
+        unsigned with_drop = stones | landing;
+        if (landing &&
+            (with_drop & (with_drop >> 1) & (with_drop >> 2) & (with_drop >> 3))) {
+            cols = static_cast<uint8_t>(cols | (1u << col));
+        }
+    }
+    return cols;
+}
+#endif  // MARLIN_TEST_HAVE_PEXT
+
+void test_win_detection() {
+    for (const WinCase& c : WIN_CASES) {
+        Position pos;
+        for (const char* p = c.moves; *p; p++) {
+            pos.make_move(*p - '1');
+        }
+
+        // One batched mask answers for all seven columns at once
+        [[maybe_unused]] uint8_t cols = winning_cols(pos);
+        assert(cols == c.win_cols);
+
+        // The per-column helper must agree bit for bit
+        for (int col = 0; col < Position::WIDTH; col++) {
+            PERF_CHECK(pos.is_winning_move(col) == ((c.win_cols >> col) & 1));
+        }
+
+#ifdef MARLIN_TEST_HAVE_PEXT
+        // The PEXT vertical check must find a subset of the full mask's
+        // winning columns (it only knows one direction)
+        [[maybe_unused]] uint8_t vcols = vertical_win_cols_pext(pos);
+        assert((vcols & ~c.win_cols) == 0);
+#endif
+
+        LOG("✓ test_win_detection: %s passed\n", c.name);
+    }
 }
 
 // ============================================================================
-// TEST 5: Horizontal win detection
+// TEST 5: Batch win-check over the same scenarios (SoA arrays)
 // ============================================================================
-void test_horizontal_win() {
-    Position pos;
-    
-    // Build a horizontal line for Player 1
-    // P1: 0, P2: 0, P1: 1, P2: 1, P1: 2, P2: 2, P1 wins at 3
-    pos.make_move(0);  // P1 at bottom of col 0
-    pos.make_move(0);  // P2 stacks on P1
-    pos.make_move(1);  // P1 at bottom of col 1
-    pos.make_move(1);  // P2 stacks
-    pos.make_move(2);  // P1 at bottom of col 2
-    pos.make_move(2);  // P2 stacks
-    
-    // P1 can win horizontally with column 3
-    assert(pos.is_winning_move(3) == true);
-    
-    std::cout << "✓ test_horizontal_win passed\n";
+void test_winning_mask_batch() {
+    constexpr size_t N = sizeof(WIN_CASES) / sizeof(WIN_CASES[0]);
+    uint64_t masks[N];
+    uint64_t players[N];
+    [[maybe_unused]] uint8_t expected[N];
+
+    // Replay every scenario into parallel mask/player arrays
+    for (size_t i = 0; i < N; i++) {
+        Position pos;
+        for (const char* p = WIN_CASES[i].moves; *p; p++) {
+            pos.make_move(*p - '1');
+        }
+        masks[i] = pos.get_mask();
+        players[i] = pos.get_position();
+        expected[i] = WIN_CASES[i].win_cols != 0 ? 1 : 0;
+    }
+
+    uint8_t out[N];
+    Position::winning_mask_batch(masks, players, out, N);
+
+    for (size_t i = 0; i < N; i++) {
+        PERF_CHECK(out[i] == expected[i]);
+    }
+
+    LOG("✓ test_winning_mask_batch passed\n");
 }
 
 // ============================================================================
-// TEST 6: Diagonal win detection (/)
+// TEST 6: Book-style lookup of expected results by position key
 // ============================================================================
-void test_diagonal_win() {
-    Position pos;
-    
-    // Create a diagonal pattern (this requires careful setup)
-    // We need: (row 0, col 0), (row 1, col 1), (row 2, col 2), (row 3, col 3)
-    // for player 1 (X)
-    
-    // Col 0: X
-    pos.make_move(0);  // P1 at (0,0) ✓
-    
-    // Col 1: O, X  
-    pos.make_move(1);  // P2 at (0,1)
-    pos.make_move(1);  // P1 at (1,1) ✓
-    
-    // Col 2: O, O, X
-    pos.make_move(2);  // P2 at (0,2)
-    pos.make_move(2);  // P1 at (1,2)
-    pos.make_move(2);  // P2 at (2,2)
-    pos.make_move(2);  // P1 at... wait, we need to be careful
-    
-    // Let's use a simpler approach - just test that the function doesn't crash
-    // A proper diagonal test requires very careful move setup
-    
-    std::cout << "✓ test_diagonal_win passed (basic check)\n";
+//
+// The engine's opening book maps Position::key() to a precomputed score
+// and answers with a lookup instead of a search. The tests mirror that
+// path in miniature: a compile-time table maps each scenario's key to
+// its expected winning columns, and the test validates a LOOKUP against
+// the live computation. (Four entries make a linear scan fine here; the
+// real book binary-searches a sorted table.)
+struct BookEntry {
+    uint64_t key;      // Position::key() of the scenario's final position
+    uint8_t win_cols;  // Expected winning columns, as in WinCase
+};
+
+static constexpr size_t N_CASES = sizeof(WIN_CASES) / sizeof(WIN_CASES[0]);
+
+// Built entirely at compile time from the same scenario table, so the
+// book can never drift out of sync with WIN_CASES.
+static constexpr std::array<BookEntry, N_CASES> make_test_book() {
+    std::array<BookEntry, N_CASES> book{};
+    for (size_t i = 0; i < N_CASES; i++) {
+        book[i] = {play(WIN_CASES[i].moves).key(), WIN_CASES[i].win_cols};
+    }
+    return book;
+}
+
+static constexpr std::array<BookEntry, N_CASES> TEST_BOOK = make_test_book();
+
+void test_book_lookup() {
+    for (const WinCase& c : WIN_CASES) {
+        Position pos;
+        for (const char* p = c.moves; *p; p++) {
+            pos.make_move(*p - '1');
+        }
+
+        // Look the position up by key, exactly like the solver's book path
+        [[maybe_unused]] const BookEntry* hit = nullptr;
+        for (const BookEntry& e : TEST_BOOK) {
+            if (e.key == pos.key()) {
+                hit = &e;
+                break;
+            }
+        }
+
+        assert(hit != nullptr);
+        PERF_CHECK(winning_cols(pos) == hit->win_cols);
+    }
+
+    LOG("✓ test_book_lookup passed\n");
 }
 
 // ============================================================================
 // MAIN - Run all tests
 // ============================================================================
 int main() {
-    std::cout << "\n=== Running Position Class Tests ===\n\n";
+    LOG("\n=== Running Position Class Tests ===\n\n");
     
     test_constructor();
     test_can_play();
     test_make_move();
-    test_vertical_win();
-    test_horizontal_win();
-    test_diagonal_win();
+    test_win_detection();
+    test_winning_mask_batch();
+    test_book_lookup();
     
-    std::cout << "\n=== All tests passed! ===\n\n";
+    LOG("\n=== All tests passed! ===\n\n");
     return 0;
 }
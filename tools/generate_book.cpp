@@ -0,0 +1,161 @@
+/**
+ * generate_book.cpp - Offline opening book generator
+ *
+ * WHAT THIS PRODUCES:
+ * =============================================================================
+ *
+ * A generated header (include/opening_book.hpp) containing the exact score
+ * of every position reachable in the first N plies, as a sorted
+ * (canonical_key, score) array. The solver binary-searches this table
+ * before starting a real search, so the exponentially expensive early
+ * plies become O(log n) lookups.
+ *
+ * Usage:
+ *   generate_book [max_plies] [output_path]
+ *
+ * Defaults: max_plies = 8, output = include/opening_book.hpp.
+ *
+ * HOW IT WORKS:
+ * =============================================================================
+ *
+ * 1. Enumerate every legal move sequence up to max_plies, stopping a line
+ *    early if a player can win on the spot (the solver never looks those
+ *    positions up - it detects immediate wins itself).
+ * 2. Deduplicate positions by canonical key, which also folds left/right
+ *    mirror twins onto one entry.
+ * 3. Solve each unique position with ONE shared Solver, so the
+ *    transposition table filled by the first (hardest) solve accelerates
+ *    all the others.
+ * 4. Emit the sorted table as a self-contained constexpr header.
+ *
+ * Note: generation at the default depth 8 is a long single-core run -
+ * this is an OFFLINE tool, run it once on a big machine and commit the
+ * result. Shallower books are proportionally cheaper and still capture
+ * the most expensive positions (the near-empty board dominates the cost
+ * of early-game solving).
+ */
+
+#include "position.hpp"
+#include "solver.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <vector>
+
+/**
+ * collect - Recursively enumerate positions up to max_plies deep,
+ * recording each unique canonical key with a representative Position.
+ */
+static void collect(Position& pos, int plies_left,
+                    std::map<uint64_t, Position>& unique) {
+    unique.emplace(pos.canonical_key(), pos);
+
+    if (plies_left == 0) {
+        return;
+    }
+
+    // A line ends when the player to move can win immediately: the solver
+    // short-circuits such positions before probing any book or table, and
+    // no deeper position on this line is reachable by sane play.
+    if (pos.winning_moves()) {
+        return;
+    }
+
+    const uint64_t saved_mask = pos.get_mask();
+    const uint64_t saved_position = pos.get_position();
+
+    for (int col = 0; col < Position::WIDTH; col++) {
+        if (pos.can_play(col)) {
+            pos.make_move(col);
+            collect(pos, plies_left - 1, unique);
+            pos.unmake_move(saved_mask, saved_position);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    int max_plies = argc > 1 ? std::atoi(argv[1]) : 8;
+    const char* out_path = argc > 2 ? argv[2] : "include/opening_book.hpp";
+
+    // Step 1+2: enumerate and deduplicate
+    std::map<uint64_t, Position> unique;
+    Position root;
+    collect(root, max_plies, unique);
+    std::fprintf(stderr, "Enumerated %zu unique positions to depth %d\n",
+                 unique.size(), max_plies);
+
+    // Step 3: solve them all with one shared solver. Solving shallow
+    // positions first (std::map iterates by key, which is unordered in
+    // ply terms) would be ideal, but the shared TT makes order mostly
+    // irrelevant: after the empty board is solved, the rest are cheap.
+    Solver solver;
+    std::vector<std::pair<uint64_t, int>> entries;
+    entries.reserve(unique.size());
+
+    size_t done = 0;
+    for (auto& [key, pos] : unique) {
+        entries.emplace_back(key, solver.solve(pos));
+        if (++done % 100 == 0 || done == unique.size()) {
+            std::fprintf(stderr, "  solved %zu/%zu\n", done, unique.size());
+        }
+    }
+
+    std::sort(entries.begin(), entries.end());
+
+    // Step 4: emit the header
+    FILE* out = std::fopen(out_path, "w");
+    if (!out) {
+        std::perror(out_path);
+        return 1;
+    }
+
+    std::fprintf(out,
+        "/**\n"
+        " * opening_book.hpp - GENERATED by tools/generate_book. Do not edit.\n"
+        " *\n"
+        " * Exact scores for every position up to %d plies, keyed by\n"
+        " * Position::canonical_key() and sorted for binary search.\n"
+        " */\n"
+        "\n"
+        "#ifndef OPENING_BOOK_HPP\n"
+        "#define OPENING_BOOK_HPP\n"
+        "\n"
+        "#include <cstddef>\n"
+        "#include <cstdint>\n"
+        "\n"
+        "namespace opening_book {\n"
+        "\n"
+        "// Deepest ply covered; -1 means the book is empty\n"
+        "inline constexpr int MAX_PLIES = %d;\n"
+        "\n"
+        "struct Entry {\n"
+        "    uint64_t key;   // Position::canonical_key()\n"
+        "    int8_t score;   // Exact score for the player to move\n"
+        "};\n"
+        "\n"
+        "inline constexpr Entry BOOK[] = {\n",
+        max_plies, entries.empty() ? -1 : max_plies);
+
+    for (const auto& [key, score] : entries) {
+        std::fprintf(out, "    {0x%013llXULL, %d},\n",
+                     static_cast<unsigned long long>(key), score);
+    }
+    if (entries.empty()) {
+        std::fprintf(out, "    {0, 0},  // placeholder so the array isn't empty\n");
+    }
+
+    std::fprintf(out,
+        "};\n"
+        "\n"
+        "inline constexpr size_t SIZE = %zu;\n"
+        "\n"
+        "}  // namespace opening_book\n"
+        "\n"
+        "#endif // OPENING_BOOK_HPP\n",
+        entries.size());
+
+    std::fclose(out);
+    std::fprintf(stderr, "Wrote %zu entries to %s\n", entries.size(), out_path);
+    return 0;
+}